@@ -20,9 +20,13 @@
  */
 
 #include "sparc.H"
+#include "sparc_icc.H"
+#include "sparc_regwin.H"
 
 using namespace sparc_parms;
 
+#include "sparc_hostmem.H"
+
 int sparc::nRegs(void) {
   return 72;
 }
@@ -30,12 +34,12 @@ int sparc::nRegs(void) {
 ac_word sparc::reg_read( int reg ) {
   /* General Purpose: G, O, L, I */
   if ( ( reg >= 0 ) && ( reg < 32 ) ) {
-    return REGS[reg];
+    return RB[regwin_index(CWP, reg)];
   }
   
   /* Y, PSR, WIM, PC, NPC */
   else if ( reg == 64 ) return Y;
-  else if ( reg == 65 ) return PSR;
+  else if ( reg == 65 ) return (PSR & ~PSR_ICC_MASK) | (icc_sync() << PSR_ICC_SHIFT);
   else if ( reg == 66 ) return WIM;
   else if ( reg == 68 ) return ac_pc;
   else if ( reg == 69 ) return npc;
@@ -48,12 +52,16 @@ ac_word sparc::reg_read( int reg ) {
 void sparc::reg_write( int reg, ac_word value ) {
   /* General Purpose: G, O, L & I regs */
   if ( ( reg >= 0 ) && ( reg < 32 ) ) {
-    REGS[reg] = value;
+    if ( reg ) RB[regwin_index(CWP, reg)] = value;
   }
   
   /* Y, PSR, WIM, PC, NPC */
   else if ( reg == 64 ) Y   = value;
-  else if ( reg == 65 ) PSR = value;
+  else if ( reg == 65 ) {
+    PSR = value;
+    set_icc(CC_OP_FLAGS, 0, 0, (value & PSR_ICC_MASK) >> PSR_ICC_SHIFT);
+    icc_sync();
+  }
   else if ( reg == 66 ) WIM = value;
   else if ( reg == 68 ) ac_pc = value;
   else if ( reg == 69 ) npc = value;
@@ -61,10 +69,12 @@ void sparc::reg_write( int reg, ac_word value ) {
 
 
 unsigned char sparc::mem_read( unsigned int address ) {
-  return DATA_PORT->read_byte( address );
+  tlb_bind( DATA_PORT );
+  return dm_read_byte( DATA_PORT, address );
 }
 
 
 void sparc::mem_write( unsigned int address, unsigned char byte ) {
-  DATA_PORT->write_byte( address, byte );
+  tlb_bind( DATA_PORT );
+  dm_write_byte( DATA_PORT, address, byte );
 }
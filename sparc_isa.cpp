@@ -37,6 +37,27 @@
 // Namespace for sparc types.
 using namespace sparc_parms;
 
+#include "sparc_icc.H"
+#include "sparc_regwin.H"
+#define SPARC_HOSTMEM_STORAGE
+#include "sparc_hostmem.H"
+#include "sparc_syscall.H"
+#include "sparc_callgraph.H"
+#include "sparc_block_cache.H"
+#include "sparc_trace_cache.H"
+#include "sparc_profile.H"
+#include "sparc_checkpoint.H"
+#include "sparc_sampling.H"
+#include "sparc_cache_explore.H"
+#include "sparc_trace_writer.H"
+#include "sparc_replay.H"
+#include "sparc_power_report.H"
+#include "sparc_spin.H"
+#include "sparc_parallel.H"
+#include "sparc_batch.H"
+#include "sparc_lockstep.H"
+#include "sparc_forksrv.H"
+
 static int processors_started = 0;
 #define DEFAULT_STACK_SIZE (256*1024)
 
@@ -59,6 +80,52 @@ void ac_behavior( instruction )
   test_sleep();
 
   dbg_printf("----- PC=0x%x  NPC=0x%x ----- #executed=%lld\n", (unsigned) ac_pc.read(), (unsigned)npc.read(), ac_instr_counter);
+
+  tlb_bind(DATA_PORT);
+  if (ac_instr_counter >= bb_event_icount || ac_pc == bb_stop_pc) {
+    if (ckpt_event(this) || fsrv_event(this)) {
+      ac_annul();
+      return;
+    }
+    smp_event(this);
+  }
+
+  if (spin_n_wake)
+    spin_deliver();
+  if (spin_n_pending)
+    spin_park(this);
+
+  if (par_quantum) {
+    //run a quantum on the host thread of this core
+    unsigned long long n = par_step(this);
+    if (n) {
+      bb_power_bind(this);
+      bb_power_dispatched();
+      ac_instr_counter += n - 1;
+      ac_annul();
+      return;
+    }
+  }
+
+  if (sparc_engine != SPARC_ENGINE_INTERP) {
+    //run from the block/trace cache and skip the generic behavior
+    bb_power_bind(this);
+    unsigned int n = bb_dispatch(this);
+    if (n) {
+      bb_power_dispatched();
+      ac_instr_counter += n - 1;
+      ac_annul();
+      return;
+    }
+  }
+
+  if (tw_on)
+    tw_begin(this);
+  prof_generic(this);
+  if (cg_on)
+    cg_account(this, 1, ac_pc);
+  if (bb_fetch_observer)
+    bb_fetch_observer(ac_pc, 1);
 }
  
 //! Instruction Format behavior methods.
@@ -71,8 +138,9 @@ void ac_behavior( Type_FT ){}
 
 //!User declared functions.
 
-#define writeReg(addr, val) REGS[addr] = (addr)? ac_word(val) : 0
-#define readReg(addr) (int)(REGS[addr])
+//Registers of the current window are views of RB (see sparc_regwin.H)
+#define writeReg(addr, val) RB[regwin_index(CWP, addr)] = (addr)? ac_word(val) : 0
+#define readReg(addr) (int)(RB[regwin_index(CWP, addr)])
 
 
 inline void update_pc(bool branch, bool taken, bool b_always, bool annul, ac_word addr, ac_reg<unsigned>& ac_pc, ac_reg<ac_word>& npc)
@@ -80,6 +148,9 @@ inline void update_pc(bool branch, bool taken, bool b_always, bool annul, ac_wor
   //Reference book: "Sparc Architecture, Assembly Language Programing, and C"
   //  Author: Richard P. Paul. Prentice Hall, Second Edition. Page 87
 
+  if (tw_cur)
+    tw_branch(branch, taken, b_always, annul);
+
   // If (not to execute next instruction)
 
 		if (branch && (!taken ||b_always) && annul) {
@@ -115,25 +186,40 @@ inline void update_pc(bool branch, bool taken, bool b_always, bool annul, ac_wor
 #endif
 
 
-void trap_reg_window_overflow(ac_memory* DATA_PORT, ac_regbank<256, ac_word, ac_Dword>& RB, ac_reg<unsigned char>& WIM)
+//!Spill the oldest windows to their stack frames
+void trap_reg_window_overflow(ac_memory* DATA_PORT, ac_regbank<RB_SIZE, ac_word, ac_Dword>& RB, ac_reg<unsigned char>& WIM, ac_reg<ac_word>& SPILLED)
 {
-  WIM = (WIM-0x10);
-  int sp = (WIM+14) & 0xFF;
-  int l0 = (WIM+16) & 0xFF;
-  for (int i=0; i<16; i++) {
-    DATA_PORT->write(RB.read(sp)+(i<<2), RB.read(l0+i));
+  for (unsigned int k = 0; k < rw_spill_depth; k++) {
+    WIM = (WIM-0x10);
+    int sp = (WIM+14) & 0xFF;
+    int l0 = (WIM+16) & 0xFF;
+    hostmem_write_words(DATA_PORT, RB.read(sp), &RB[l0], 16);
   }
+  SPILLED = SPILLED + rw_spill_depth;
+  if (tw_cur)
+    tw_window(TF_OVERFLOW, rw_spill_depth);
+  rw_overflows++;
+  rw_spilled += rw_spill_depth;
 }
 
 
-void trap_reg_window_underflow(ac_memory* DATA_PORT, ac_regbank<256, ac_word, ac_Dword>& RB, ac_reg<unsigned char>& WIM)
+//!Fill the current window and the ones above it from their stack frames
+void trap_reg_window_underflow(ac_memory* DATA_PORT, ac_regbank<RB_SIZE, ac_word, ac_Dword>& RB, ac_reg<unsigned char>& WIM, ac_reg<ac_word>& SPILLED)
 {
-  int sp = (WIM+14) & 0xFF;
-  int l0 = (WIM+16) & 0xFF;
-  for (int i=0; i<16; i++) {
-    RB.write(l0+i, DATA_PORT->read(RB.read(sp)+(i<<2)));
+  unsigned int n = rw_spill_depth;
+  if (n > SPILLED)
+    n = SPILLED ? (unsigned int) SPILLED : 1;
+  for (unsigned int k = 0; k < n; k++) {
+    int sp = (WIM+14) & 0xFF;
+    int l0 = (WIM+16) & 0xFF;
+    hostmem_read_words(DATA_PORT, RB.read(sp), &RB[l0], 16);
+    WIM = (WIM+0x10);
   }
-  WIM = (WIM+0x10);
+  SPILLED = (SPILLED > n) ? SPILLED - n : 0;
+  if (tw_cur)
+    tw_window(TF_UNDERFLOW, n);
+  rw_underflows++;
+  rw_filled += n;
 }
 
 
@@ -141,19 +227,57 @@ void trap_reg_window_underflow(ac_memory* DATA_PORT, ac_regbank<256, ac_word, ac
 void ac_behavior(begin)
 {
   dbg_printf("@@@ begin behavior @@@\n");
-  REGS[0] = 0;  //writeReg can't initialize register 0
+  RB[RB_GLOBALS] = 0;  //writeReg can't initialize register 0
   npc = ac_pc + 4;
 
-  CWP = 0xF0;
+  //Start in window 0, where set_prog_args() left argc/argv; the 15th
+  //nested save overflows into WIM
+  CWP = 0;
+  WIM = 0x10;
+  set_icc(CC_OP_FLAGS, 0, 0, 0);
+
+  //Loads and stores reach the DM storage directly
+  if (!hostmem_map_storage(DATA_PORT) && !hostmem_ram_mapped(DATA_PORT) && processors_started == 0)
+    fprintf(stderr, "ArchC: DATA_PORT is not an ArchC storage, guest RAM is reached through the port\n");
+  tlb_bind(DATA_PORT);
+  bb_select_engine();
+  tr_select_threshold();
+  rw_select_spill_depth();
+  ram_select(DATA_PORT);
+  prof_select();
+  batch_select(this);
  /* sp for multi-core platforms */ 
-  writeReg(14,AC_RAM_END - 1024 - processors_started++ * DEFAULT_STACK_SIZE);
-
+  writeReg(14,sparc_stack_top - __sync_fetch_and_add(&processors_started, 1) * DEFAULT_STACK_SIZE);
+  bb_power_select(this, processors_started - 1);
+  cg_select(this);
+  ckpt_select(this, processors_started - 1);
+  fsrv_select(this, processors_started - 1);
+  smp_select(this);
+  cx_select();
+  pr_select();
+  rp_select();
+  tw_select(this, processors_started - 1);
+  spin_select();
+  par_select(this);
 }
 
 //!Function called after simulation end
 void ac_behavior(end)
 {
   dbg_printf("@@@ end behavior @@@\n");
+  bb_report();
+  tr_report();
+  rw_report();
+  tlb_report();
+  ram_report();
+  smp_report(ac_instr_counter);
+  cx_report();
+  tw_report(this);
+  spin_report();
+  par_report();
+  prof_report();
+  cg_report();
+  batch_report(ac_instr_counter);
 }
 
 
@@ -165,6 +289,8 @@ void ac_behavior(end)
 void ac_behavior( call )
 {
   dbg_printf("call 0x%x\n", ac_pc+(disp30<<2));
+  if (cg_on)
+    cg_jump(this, ac_pc, ac_pc+(disp30<<2), 15);
   writeReg(15, ac_pc); //saves ac_pc in %o7(or %r15)
   update_pc(1,1,1,0, ac_pc+(disp30<<2), ac_pc, npc);
 };
@@ -202,105 +328,105 @@ void ac_behavior( bn )
 void ac_behavior( bne )
 {
   dbg_printf("bne 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, !PSR_icc_z, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction be behavior method.
 void ac_behavior( be )
 {
   dbg_printf("be 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, PSR_icc_z, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bg behavior method.
 void ac_behavior( bg )
 {
   dbg_printf("bg 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, !(PSR_icc_z ||(PSR_icc_n ^PSR_icc_v)), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction ble behavior method.
 void ac_behavior( ble )
 {
   dbg_printf("ble 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, PSR_icc_z ||(PSR_icc_n ^PSR_icc_v), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bge behavior method.
 void ac_behavior( bge )
 {
   dbg_printf("bge 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, !(PSR_icc_n ^PSR_icc_v), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bl behavior method.
 void ac_behavior( bl )
 {
   dbg_printf("bl 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, PSR_icc_n ^PSR_icc_v, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bgu behavior method.
 void ac_behavior( bgu )
 {
   dbg_printf("bgu 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, !(PSR_icc_c ||PSR_icc_z), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bleu behavior method.
 void ac_behavior( bleu )
 {
   dbg_printf("bleu 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, PSR_icc_c ||PSR_icc_z, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bcc behavior method.
 void ac_behavior( bcc )
 {
   dbg_printf("bcc 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, !PSR_icc_c, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bcs behavior method.
 void ac_behavior( bcs )
 {
   dbg_printf("bcs 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, PSR_icc_c, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bpos behavior method.
 void ac_behavior( bpos )
 {
   dbg_printf("bpos 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, !PSR_icc_n, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bneg behavior method.
 void ac_behavior( bneg )
 {
   dbg_printf("bneg 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, PSR_icc_n, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bvc behavior method.
 void ac_behavior( bvc )
 {
   dbg_printf("bvc 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, !PSR_icc_v, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 ///!Instruction bvs behavior method.
 void ac_behavior( bvs )
 {
   dbg_printf("bvs 0x%x\n", ac_pc+(disp22<<2));
-  update_pc(1, PSR_icc_v, 0, an, ac_pc+(disp22<<2), ac_pc, npc);
+  update_pc(1, icc_test(cond, read_icc()), 0, an, ac_pc+(disp22<<2), ac_pc, npc);
 };
 
 //!Instruction ldsb_reg behavior method.
 void ac_behavior( ldsb_reg )
 {
   dbg_printf("ldsb_reg [r%d+r%d], r%d\n", rs1, rs2, rd);
-  writeReg(rd, (int)(char) DATA_PORT->read_byte(readReg(rs1) + readReg(rs2)));
+  writeReg(rd, (int)(char) dm_read_byte(DATA_PORT, readReg(rs1) + readReg(rs2)));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -309,7 +435,7 @@ void ac_behavior( ldsb_reg )
 void ac_behavior( ldsh_reg )
 {
   dbg_printf("ldsh_reg [r%d+r%d], r%d\n", rs1, rs2, rd);
-  writeReg(rd, (int)(short) DATA_PORT->read_half(readReg(rs1) + readReg(rs2)));
+  writeReg(rd, (int)(short) dm_read_half(DATA_PORT, readReg(rs1) + readReg(rs2)));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -318,7 +444,7 @@ void ac_behavior( ldsh_reg )
 void ac_behavior( ldub_reg )
 {
   dbg_printf("ldub_reg [r%d+r%d], r%d\n", rs1, rs2, rd);
-  writeReg(rd, DATA_PORT->read_byte(readReg(rs1) + readReg(rs2)));
+  writeReg(rd, dm_read_byte(DATA_PORT, readReg(rs1) + readReg(rs2)));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -327,7 +453,7 @@ void ac_behavior( ldub_reg )
 void ac_behavior( lduh_reg )
 {
   dbg_printf("lduh_reg [r%d+r%d], r%d\n", rs1, rs2, rd);
-  writeReg(rd, DATA_PORT->read_half(readReg(rs1) + readReg(rs2)));
+  writeReg(rd, dm_read_half(DATA_PORT, readReg(rs1) + readReg(rs2)));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -336,7 +462,7 @@ void ac_behavior( lduh_reg )
 void ac_behavior( ld_reg )
 {
   dbg_printf("ld_reg [r%d+r%d], r%d\n", rs1, rs2, rd);
-  writeReg(rd, DATA_PORT->read(readReg(rs1) + readReg(rs2)));
+  writeReg(rd, dm_read(DATA_PORT, readReg(rs1) + readReg(rs2)));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -345,9 +471,9 @@ void ac_behavior( ld_reg )
 void ac_behavior( ldd_reg )
 {
   dbg_printf("ldd_reg [r%d+r%d], r%d\n", rs1, rs2, rd);
-  int tmp = DATA_PORT->read(readReg(rs1) + readReg(rs2) + 4);
-  writeReg(rd,   DATA_PORT->read(readReg(rs1) + readReg(rs2)    ));
-  writeReg(rd+1, tmp);
+  ac_Dword tmp = dm_read_dword(DATA_PORT, readReg(rs1) + readReg(rs2));
+  writeReg(rd,   (ac_word) (tmp >> 32));
+  writeReg(rd+1, (ac_word) tmp);
   dbg_printf("Result = 0x%x\n", readReg(rd));
   dbg_printf("Result = 0x%x\n", readReg(rd+1));
   update_pc(0,0,0,0,0, ac_pc, npc);
@@ -357,7 +483,7 @@ void ac_behavior( ldd_reg )
 void ac_behavior( stb_reg )
 {
   dbg_printf("stb_reg r%d, [r%d+r%d]\n", rd, rs1, rs2);
-  DATA_PORT->write_byte(readReg(rs1) + readReg(rs2), (char) readReg(rd));
+  dm_write_byte(DATA_PORT, readReg(rs1) + readReg(rs2), (char) readReg(rd));
   dbg_printf("Result = 0x%x\n", (char) readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -366,7 +492,7 @@ void ac_behavior( stb_reg )
 void ac_behavior( sth_reg )
 {
   dbg_printf("sth_reg r%d, [r%d+r%d]\n", rd, rs1, rs2);
-  DATA_PORT->write_half(readReg(rs1) + readReg(rs2), (short) readReg(rd));
+  dm_write_half(DATA_PORT, readReg(rs1) + readReg(rs2), (short) readReg(rd));
   dbg_printf("Result = 0x%x\n", (short) readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -375,7 +501,7 @@ void ac_behavior( sth_reg )
 void ac_behavior( st_reg )
 {
   dbg_printf("st_reg r%d, [r%d+r%d]\n", rd, rs1, rs2);
-  DATA_PORT->write(readReg(rs1) + readReg(rs2), readReg(rd));
+  dm_write(DATA_PORT, readReg(rs1) + readReg(rs2), readReg(rd));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -384,8 +510,7 @@ void ac_behavior( st_reg )
 void ac_behavior( std_reg )
 {
   dbg_printf("std_reg r%d, [r%d+r%d]\n", rd, rs1, rs2);
-  DATA_PORT->write(readReg(rs1) + readReg(rs2),     readReg(rd  ));
-  DATA_PORT->write(readReg(rs1) + readReg(rs2) + 4, readReg(rd+1));
+  dm_write_dword(DATA_PORT, readReg(rs1) + readReg(rs2), ((ac_Dword) (ac_word) readReg(rd) << 32) | (ac_word) readReg(rd+1));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   dbg_printf("Result = 0x%x\n", readReg(rd+1));
   update_pc(0,0,0,0,0, ac_pc, npc);
@@ -395,8 +520,10 @@ void ac_behavior( std_reg )
 void ac_behavior( ldstub_reg )
 {
   dbg_printf("atomic ldstub_reg r%d, [r%d+r%d]\n", rd, rs1, rs2);
-  writeReg(rd, DATA_PORT->read_byte(readReg(rs1) + readReg(rs2)));
-  DATA_PORT->write_byte(readReg(rs1) + readReg(rs2), 0xFF);
+  unsigned int addr = readReg(rs1) + readReg(rs2);
+  unsigned char old = dm_ldstub(DATA_PORT, addr);
+  writeReg(rd, old);
+  spin_check(this, addr, old);
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
 
@@ -404,9 +531,8 @@ void ac_behavior( ldstub_reg )
 void ac_behavior( swap_reg )
 {
   dbg_printf("swap_reg r%d, [r%d+r%d]\n", rd, rs1, rs2);
-  int swap_temp = DATA_PORT->read(readReg(rs1) + readReg(rs2));
-  DATA_PORT->write(readReg(rs1) + readReg(rs2), readReg(rd));
-  writeReg(rd, swap_temp);
+  unsigned int addr = readReg(rs1) + readReg(rs2);
+  writeReg(rd, dm_swap(DATA_PORT, addr, readReg(rd)));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
 
@@ -452,12 +578,7 @@ void ac_behavior( addcc_reg )
   dbg_printf("addcc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int dest = readReg(rs1) + readReg(rs2);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( readReg(rs1) &  readReg(rs2) & ~dest & 0x80000000) |
-	       (~readReg(rs1) & ~readReg(rs2) &  dest & 0x80000000) );
-  PSR_icc_c = ((readReg(rs1) & readReg(rs2) & 0x80000000) |
-	       (~dest & (readReg(rs1) | readReg(rs2)) & 0x80000000) );
+  set_icc(CC_OP_ADD, readReg(rs1), readReg(rs2), dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -468,7 +589,7 @@ void ac_behavior( addcc_reg )
 void ac_behavior( addx_reg )
 {
   dbg_printf("addx_reg r%d,r%d,r%d\n", rs1, rs2, rd);
-  writeReg(rd, readReg(rs1) + readReg(rs2) + PSR_icc_c);
+  writeReg(rd, readReg(rs1) + readReg(rs2) + (read_icc() & ICC_C));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -477,14 +598,9 @@ void ac_behavior( addx_reg )
 void ac_behavior( addxcc_reg )
 {
   dbg_printf("addxcc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
-  int dest = readReg(rs1) + readReg(rs2) + PSR_icc_c;
+  int dest = readReg(rs1) + readReg(rs2) + (read_icc() & ICC_C);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( readReg(rs1) &  readReg(rs2) & ~dest & 0x80000000) |
-	       (~readReg(rs1) & ~readReg(rs2) &  dest & 0x80000000) );
-  PSR_icc_c = ((readReg(rs1) & readReg(rs2) & 0x80000000) |
-	       (~dest & (readReg(rs1) | readReg(rs2)) & 0x80000000) );
+  set_icc(CC_OP_ADD, readReg(rs1), readReg(rs2), dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -506,12 +622,7 @@ void ac_behavior( subcc_reg )
   dbg_printf("subcc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int dest = readReg(rs1) - readReg(rs2);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( readReg(rs1) & ~readReg(rs2) & ~dest & 0x80000000) |
-	       (~readReg(rs1) &  readReg(rs2) &  dest & 0x80000000) );
-  PSR_icc_c = ((~readReg(rs1) & readReg(rs2) & 0x80000000) |
-	       (dest & (~readReg(rs1) | readReg(rs2)) & 0x80000000) );
+  set_icc(CC_OP_SUB, readReg(rs1), readReg(rs2), dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -522,7 +633,7 @@ void ac_behavior( subcc_reg )
 void ac_behavior( subx_reg )
 {
   dbg_printf("subx_reg r%d,r%d,r%d\n", rs1, rs2, rd);
-  writeReg(rd, readReg(rs1) - readReg(rs2) - PSR_icc_c);
+  writeReg(rd, readReg(rs1) - readReg(rs2) - (read_icc() & ICC_C));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -531,14 +642,9 @@ void ac_behavior( subx_reg )
 void ac_behavior( subxcc_reg )
 {
   dbg_printf("subxcc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
-  int dest = readReg(rs1) - readReg(rs2) - PSR_icc_c;
+  int dest = readReg(rs1) - readReg(rs2) - (read_icc() & ICC_C);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( readReg(rs1) & ~readReg(rs2) & ~dest & 0x80000000) |
-	       (~readReg(rs1) &  readReg(rs2) &  dest & 0x80000000) );
-  PSR_icc_c = ((~readReg(rs1) & readReg(rs2) & 0x80000000) |
-	       (dest & (~readReg(rs1) | readReg(rs2)) & 0x80000000) );
+  set_icc(CC_OP_SUB, readReg(rs1), readReg(rs2), dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -560,10 +666,7 @@ void ac_behavior( andcc_reg )
   dbg_printf("andcc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int dest = readReg(rs1) & readReg(rs2);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -585,10 +688,7 @@ void ac_behavior( andncc_reg )
   dbg_printf("andncc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int dest = readReg(rs1) & ~readReg(rs2);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -610,10 +710,7 @@ void ac_behavior( orcc_reg )
   dbg_printf("orcc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int dest = readReg(rs1) | readReg(rs2);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -635,10 +732,7 @@ void ac_behavior( orncc_reg )
   dbg_printf("orncc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int dest = readReg(rs1) | ~readReg(rs2);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -660,10 +754,7 @@ void ac_behavior( xorcc_reg )
   dbg_printf("xorcc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int dest = readReg(rs1) ^ readReg(rs2);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -685,10 +776,7 @@ void ac_behavior( xnorcc_reg )
   dbg_printf("xnorcc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int dest = ~(readReg(rs1) ^ readReg(rs2));
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -701,24 +789,9 @@ void ac_behavior( save_reg )
   dbg_printf("save_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int tmp = readReg(rs1) + readReg(rs2);
 
-  //copy ins and locals to RB
-  for (int i=16; i<32; i++) {
-    RB.write((CWP + i) & 0xFF, REGS[i]);
-  }
-
-  //move out to in
-  for (int i=0; i<8; i++) {
-    REGS[i+24] = REGS[i+8];
-  }
-
-  //realy change reg window
+  //change reg window: the outs become the ins of the new window
   CWP = (CWP-0x10);
-  if (CWP == WIM) trap_reg_window_overflow(DATA_PORT, RB, WIM);
-
-  //copy local and out from buffer
-  for (int i=8; i<24; i++) {
-    REGS[i] = RB.read((CWP + i) & 0xFF);
-  }
+  if (CWP == WIM) trap_reg_window_overflow(DATA_PORT, RB, WIM, SPILLED);
 
   writeReg(rd, tmp);
   dbg_printf(C_INVERSE "CWP: %d" C_RESET LF, CWP>>4);
@@ -732,24 +805,9 @@ void ac_behavior( restore_reg )
   dbg_printf("restore_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   int tmp = readReg(rs1) + readReg(rs2);
 
-  //copy locals and out to buffer
-  for (int i=8; i<24; i++) {
-    RB.write((CWP + i) & 0xFF, REGS[i]);
-  }
-
-  //move in to out
-  for (int i=0; i<8; i++) {
-    REGS[i+8] = REGS[i+24];
-  }
-
-  //realy change reg window
+  //change reg window: the ins become the outs of the new window
   CWP = (CWP+0x10);
-  if (CWP == WIM) trap_reg_window_underflow(DATA_PORT, RB, WIM);
-
-  //copy in and local from buffer
-  for (int i=16; i<32; i++) {
-    REGS[i] = RB.read((CWP + i) & 0xFF);
-  }
+  if (CWP == WIM) trap_reg_window_underflow(DATA_PORT, RB, WIM, SPILLED);
 
   writeReg(rd, tmp);
   dbg_printf(C_INVERSE "CWP: %d" C_RESET LF, CWP>>4);
@@ -785,10 +843,7 @@ void ac_behavior( umulcc_reg )
   dbg_printf("umul_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   unsigned long long tmp = (unsigned long long) (unsigned) readReg(rs1) * (unsigned long long) (unsigned) readReg(rs2);
 
-  PSR_icc_n = (unsigned int) tmp >> 31;
-  PSR_icc_z = (unsigned int) tmp == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, (unsigned int) tmp);
 
   writeReg(rd, (unsigned int) tmp);
   Y.write( (unsigned int) (tmp >> 32));
@@ -802,10 +857,7 @@ void ac_behavior( smulcc_reg )
   dbg_printf("smulcc_reg r%d,r%d,r%d\n", rs1, rs2, rd);
   long long tmp = (long long) readReg(rs1) * (long long) readReg(rs2);
 
-  PSR_icc_n = (unsigned int) tmp >> 31;
-  PSR_icc_z = (unsigned int) tmp == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, (unsigned int) tmp);
 
   writeReg(rd, (int) tmp);
   Y.write( (int) (tmp >> 32));
@@ -841,10 +893,7 @@ void ac_behavior( udivcc_reg )
   bool temp_v = ((tmp >> 32) == 0) ? 0 : 1;
   if (temp_v) result = 0xFFFFFFFF;
 
-  PSR_icc_n = result >> 31;
-  PSR_icc_z = result == 0;
-  PSR_icc_v = temp_v;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_FLAGS, 0, 0, icc_pack(result >> 31, result == 0, temp_v, 0));
 
   writeReg(rd, result);
   dbg_printf("Result = 0x%x\n", readReg(rd));
@@ -887,10 +936,7 @@ void ac_behavior( sdivcc_reg )
     else result = 0x80000000;
   }
 
-  PSR_icc_n = result >> 31;
-  PSR_icc_z = result == 0;
-  PSR_icc_v = temp_v;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_FLAGS, 0, 0, icc_pack(result >> 31, result == 0, temp_v, 0));
 
   writeReg(rd, result);
   dbg_printf("Result = 0x%x\n", readReg(rd));
@@ -901,6 +947,8 @@ void ac_behavior( sdivcc_reg )
 void ac_behavior( jmpl_reg )
 {
   dbg_printf("jmpl_reg r%d,r%d,r%d\n", rs1, rs2, rd);
+  if (cg_on)
+    cg_jump(this, ac_pc, readReg(rs1) + readReg(rs2), rd);
   writeReg(rd, ac_pc);
   //TODO: ugly: create a way to jump from a register without mapping
   update_pc(1,1,1,0, readReg(rs1) + readReg(rs2), ac_pc, npc);
@@ -918,7 +966,7 @@ void ac_behavior( wry_reg )
 void ac_behavior( ldsb_imm )
 {
   dbg_printf("ldsb_imm [r%d + %d], r%d\n", rs1, simm13, rd);
-  writeReg(rd, (int)(char) DATA_PORT->read_byte(readReg(rs1) + simm13));
+  writeReg(rd, (int)(char) dm_read_byte(DATA_PORT, readReg(rs1) + simm13));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -927,7 +975,7 @@ void ac_behavior( ldsb_imm )
 void ac_behavior( ldsh_imm )
 {
   dbg_printf("ldsh_imm [r%d + %d], r%d\n", rs1, simm13, rd);
-  writeReg(rd, (int)(short) DATA_PORT->read_half(readReg(rs1) + simm13));
+  writeReg(rd, (int)(short) dm_read_half(DATA_PORT, readReg(rs1) + simm13));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -936,7 +984,7 @@ void ac_behavior( ldsh_imm )
 void ac_behavior( ldub_imm )
 {
   dbg_printf("ldub_imm [r%d + %d], r%d\n", rs1, simm13, rd);
-  writeReg(rd, DATA_PORT->read_byte(readReg(rs1) + simm13));
+  writeReg(rd, dm_read_byte(DATA_PORT, readReg(rs1) + simm13));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -945,7 +993,7 @@ void ac_behavior( ldub_imm )
 void ac_behavior( lduh_imm )
 {
   dbg_printf("lduh_imm [r%d + %d], r%d\n", rs1, simm13, rd);
-  writeReg(rd, DATA_PORT->read_half(readReg(rs1) + simm13));
+  writeReg(rd, dm_read_half(DATA_PORT, readReg(rs1) + simm13));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -954,7 +1002,7 @@ void ac_behavior( lduh_imm )
 void ac_behavior( ld_imm )
 {
   dbg_printf("ld_imm [r%d + %d], r%d\n", rs1, simm13, rd);
-  writeReg(rd, DATA_PORT->read(readReg(rs1) + simm13));
+  writeReg(rd, dm_read(DATA_PORT, readReg(rs1) + simm13));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -963,9 +1011,9 @@ void ac_behavior( ld_imm )
 void ac_behavior( ldd_imm )
 {
   dbg_printf("ldd_imm [r%d + %d], r%d\n", rs1, simm13, rd);
-  int tmp = DATA_PORT->read(readReg(rs1) + simm13 + 4);
-  writeReg(rd,   DATA_PORT->read(readReg(rs1) + simm13));
-  writeReg(rd+1, tmp);
+  ac_Dword tmp = dm_read_dword(DATA_PORT, readReg(rs1) + simm13);
+  writeReg(rd,   (ac_word) (tmp >> 32));
+  writeReg(rd+1, (ac_word) tmp);
   dbg_printf("Result = 0x%x\n", readReg(rd));
   dbg_printf("Result = 0x%x\n", readReg(rd+1));
   update_pc(0,0,0,0,0, ac_pc, npc);
@@ -986,10 +1034,7 @@ void ac_behavior( andcc_imm )
   dbg_printf("andcc_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
   int dest = readReg(rs1) & simm13;
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1011,10 +1056,7 @@ void ac_behavior( andncc_imm )
   dbg_printf("andncc_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
   int dest = readReg(rs1) & ~simm13;
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1036,10 +1078,7 @@ void ac_behavior( orcc_imm )
   dbg_printf("orcc_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
   int dest = readReg(rs1) | simm13;
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1061,10 +1100,7 @@ void ac_behavior( orncc_imm )
   dbg_printf("orn_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
   int dest = readReg(rs1) | ~simm13;
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1086,10 +1122,7 @@ void ac_behavior( xorcc_imm )
   dbg_printf("xorcc_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
   int dest = readReg(rs1) ^ simm13;
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1111,10 +1144,7 @@ void ac_behavior( xnorcc_imm )
   dbg_printf("xnorcc_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
   int dest = ~(readReg(rs1) ^ simm13);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1149,10 +1179,7 @@ void ac_behavior( umulcc_imm )
   dbg_printf("umulcc_imm r%d,%d,r%d\n", rs1, simm13, rd);
   unsigned long long tmp = (unsigned long long) (unsigned) readReg(rs1) * (unsigned long long) (unsigned) simm13;
 
-  PSR_icc_n = (unsigned int) tmp >> 31;
-  PSR_icc_z = (unsigned int) tmp == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, (unsigned int) tmp);
 
   writeReg(rd, (unsigned int) tmp);
   Y.write( (unsigned int) (tmp >> 32));
@@ -1166,10 +1193,7 @@ void ac_behavior( smulcc_imm )
   dbg_printf("smulcc_imm r%d,%d,r%d\n", rs1, simm13, rd);
   long long tmp = (long long) readReg(rs1) * (long long) simm13;
 
-  PSR_icc_n = (unsigned int) tmp >> 31;
-  PSR_icc_z = (unsigned int) tmp == 0;
-  PSR_icc_v = 0;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_LOGIC, 0, 0, (unsigned int) tmp);
 
   writeReg(rd, (int) tmp);
   Y.write( (int) (tmp >> 32));
@@ -1205,10 +1229,7 @@ void ac_behavior( udivcc_imm )
   bool temp_v = ((tmp >> 32) == 0) ? 0 : 1;
   if (temp_v) result = 0xFFFFFFFF;
 
-  PSR_icc_n = result >> 31;
-  PSR_icc_z = result == 0;
-  PSR_icc_v = temp_v;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_FLAGS, 0, 0, icc_pack(result >> 31, result == 0, temp_v, 0));
 
   writeReg(rd, result);
   dbg_printf("Result = 0x%x\n", readReg(rd));
@@ -1251,10 +1272,7 @@ void ac_behavior( sdivcc_imm )
     else result = 0x80000000;
   }
 
-  PSR_icc_n = result >> 31;
-  PSR_icc_z = result == 0;
-  PSR_icc_v = temp_v;
-  PSR_icc_c = 0;
+  set_icc(CC_OP_FLAGS, 0, 0, icc_pack(result >> 31, result == 0, temp_v, 0));
 
   writeReg(rd, result);
   dbg_printf("Result = 0x%x\n", readReg(rd));
@@ -1265,7 +1283,7 @@ void ac_behavior( sdivcc_imm )
 void ac_behavior( stb_imm )
 {
   dbg_printf("stb_imm r%d, [r%d + %d]\n", rd, rs1, simm13);
-  DATA_PORT->write_byte(readReg(rs1) + simm13, (char) readReg(rd));
+  dm_write_byte(DATA_PORT, readReg(rs1) + simm13, (char) readReg(rd));
   dbg_printf("Result = 0x%x\n", (char) readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -1274,7 +1292,7 @@ void ac_behavior( stb_imm )
 void ac_behavior( sth_imm )
 {
   dbg_printf("sth_imm r%d, [r%d + %d]\n", rd, rs1, simm13);
-  DATA_PORT->write_half(readReg(rs1) + simm13, (short) readReg(rd));
+  dm_write_half(DATA_PORT, readReg(rs1) + simm13, (short) readReg(rd));
   dbg_printf("Result = 0x%x\n", (short) readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -1283,7 +1301,7 @@ void ac_behavior( sth_imm )
 void ac_behavior( st_imm )
 {
   dbg_printf("st_imm r%d, [r%d + %d]\n", rd, rs1, simm13);
-  DATA_PORT->write(readReg(rs1) + simm13, readReg(rd));
+  dm_write(DATA_PORT, readReg(rs1) + simm13, readReg(rd));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -1292,8 +1310,7 @@ void ac_behavior( st_imm )
 void ac_behavior( std_imm )
 {
   dbg_printf("std_imm r%d, [r%d + %d]\n", rd, rs1, simm13);
-  DATA_PORT->write(readReg(rs1) + simm13,     readReg(rd  ));
-  DATA_PORT->write(readReg(rs1) + simm13 + 4, readReg(rd+1));
+  dm_write_dword(DATA_PORT, readReg(rs1) + simm13, ((ac_Dword) (ac_word) readReg(rd) << 32) | (ac_word) readReg(rd+1));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   dbg_printf("Result = 0x%x\n", readReg(rd+1));
   update_pc(0,0,0,0,0, ac_pc, npc);
@@ -1303,8 +1320,10 @@ void ac_behavior( std_imm )
 void ac_behavior( ldstub_imm )
 {
   dbg_printf("atomic ldstub_imm r%d, [r%d + %d]\n", rd, rs1, simm13);
-  writeReg(rd, DATA_PORT->read_byte(readReg(rs1) + simm13));
-  DATA_PORT->write_byte(readReg(rs1) + simm13, 0xFF);
+  unsigned int addr = readReg(rs1) + simm13;
+  unsigned char old = dm_ldstub(DATA_PORT, addr);
+  writeReg(rd, old);
+  spin_check(this, addr, old);
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
 
@@ -1312,9 +1331,8 @@ void ac_behavior( ldstub_imm )
 void ac_behavior( swap_imm )
 {
   dbg_printf("swap_imm r%d, [r%d + %d]\n", rd, rs1, simm13);
-  int swap_temp = DATA_PORT->read(readReg(rs1) + simm13);
-  DATA_PORT->write(readReg(rs1) + simm13, readReg(rd));
-  writeReg(rd, swap_temp);
+  unsigned int addr = readReg(rs1) + simm13;
+  writeReg(rd, dm_swap(DATA_PORT, addr, readReg(rd)));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
 
@@ -1360,12 +1378,7 @@ void ac_behavior( addcc_imm )
   dbg_printf("addcc_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
   int dest = readReg(rs1) + simm13;
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( readReg(rs1) &  simm13 & ~dest & 0x80000000) |
-	       (~readReg(rs1) & ~simm13 &  dest & 0x80000000) );
-  PSR_icc_c = ((readReg(rs1) & simm13 & 0x80000000) |
-	       (~dest & (readReg(rs1) | simm13) & 0x80000000) );
+  set_icc(CC_OP_ADD, readReg(rs1), simm13, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1376,7 +1389,7 @@ void ac_behavior( addcc_imm )
 void ac_behavior( addx_imm )
 {
   dbg_printf("addx_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
-  writeReg(rd, readReg(rs1) + simm13 + PSR_icc_c);
+  writeReg(rd, readReg(rs1) + simm13 + (read_icc() & ICC_C));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -1385,14 +1398,9 @@ void ac_behavior( addx_imm )
 void ac_behavior( addxcc_imm )
 {
   dbg_printf("addxcc_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
-  int dest = readReg(rs1) + simm13 + PSR_icc_c;
+  int dest = readReg(rs1) + simm13 + (read_icc() & ICC_C);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( readReg(rs1) &  simm13 & ~dest & 0x80000000) |
-	       (~readReg(rs1) & ~simm13 &  dest & 0x80000000) );
-  PSR_icc_c = ((readReg(rs1) & simm13 & 0x80000000) |
-	       (~dest & (readReg(rs1) | simm13) & 0x80000000) );
+  set_icc(CC_OP_ADD, readReg(rs1), simm13, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1414,12 +1422,7 @@ void ac_behavior( subcc_imm )
   dbg_printf("subcc_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
   int dest = readReg(rs1) - simm13;
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( readReg(rs1) & ~simm13 & ~dest & 0x80000000) |
-	       (~readReg(rs1) &  simm13 &  dest & 0x80000000) );
-  PSR_icc_c = ((~readReg(rs1) & simm13 & 0x80000000) |
-	       (dest & (~readReg(rs1) | simm13) & 0x80000000) );
+  set_icc(CC_OP_SUB, readReg(rs1), simm13, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1430,7 +1433,7 @@ void ac_behavior( subcc_imm )
 void ac_behavior( subx_imm )
 {
   dbg_printf("subx_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
-  writeReg(rd, readReg(rs1) - simm13 - PSR_icc_c);
+  writeReg(rd, readReg(rs1) - simm13 - (read_icc() & ICC_C));
   dbg_printf("Result = 0x%x\n", readReg(rd));
   update_pc(0,0,0,0,0, ac_pc, npc);
 };
@@ -1439,14 +1442,9 @@ void ac_behavior( subx_imm )
 void ac_behavior( subxcc_imm )
 {
   dbg_printf("subxcc_imm r%d,0x%x,r%d\n", rs1, simm13, rd);
-  int dest = readReg(rs1) - simm13 - PSR_icc_c;
+  int dest = readReg(rs1) - simm13 - (read_icc() & ICC_C);
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( readReg(rs1) & ~simm13 & ~dest & 0x80000000) |
-	       (~readReg(rs1) &  simm13 &  dest & 0x80000000) );
-  PSR_icc_c = ((~readReg(rs1) & simm13 & 0x80000000) |
-	       (dest & (~readReg(rs1) | simm13) & 0x80000000) );
+  set_icc(CC_OP_SUB, readReg(rs1), simm13, dest);
 
   writeReg(rd, dest);
   dbg_printf("Result = 0x%x\n", dest);
@@ -1457,6 +1455,8 @@ void ac_behavior( subxcc_imm )
 void ac_behavior( jmpl_imm )
 {
   dbg_printf("jmpl_imm r%d,%d,r%d\n", rs1, simm13, rd);
+  if (cg_on)
+    cg_jump(this, ac_pc, readReg(rs1) + simm13, rd);
   writeReg(rd, ac_pc);
   update_pc(1,1,1,0, readReg(rs1) + simm13, ac_pc, npc);
 };
@@ -1467,24 +1467,9 @@ void ac_behavior( save_imm )
   dbg_printf("save_imm r%d, %d, r%d\n", rs1, simm13, rd);
   int tmp = readReg(rs1) + simm13;
 
-  //copy ins and locals to RB
-  for (int i=16; i<32; i++) {
-    RB.write((CWP + i) & 0xFF, REGS[i]);
-  }
-
-  //move out to in
-  for (int i=0; i<8; i++) {
-    REGS[i+24] = REGS[i+8];
-  }
-
-  //realy change reg window
+  //change reg window: the outs become the ins of the new window
   CWP = (CWP-0x10);
-  if (CWP == WIM) trap_reg_window_overflow(DATA_PORT, RB, WIM);
-
-  //copy local and out from buffer
-  for (int i=8; i<24; i++) {
-    REGS[i] = RB.read((CWP + i) & 0xFF);
-  }
+  if (CWP == WIM) trap_reg_window_overflow(DATA_PORT, RB, WIM, SPILLED);
 
   writeReg(rd, tmp);
   dbg_printf(C_INVERSE "CWP: %d" C_RESET LF, CWP>>4);
@@ -1498,24 +1483,9 @@ void ac_behavior( restore_imm )
   dbg_printf("restore_imm r%d, %d, r%d\n", rs1, simm13, rd);
   int tmp = readReg(rs1) + simm13;
 
-  //copy locals and out to buffer
-  for (int i=8; i<24; i++) {
-    RB.write((CWP + i) & 0xFF, REGS[i]);
-  }
-
-  //move in to out
-  for (int i=0; i<8; i++) {
-    REGS[i+8] = REGS[i+24];
-  }
-
-  //realy change reg window
+  //change reg window: the ins become the outs of the new window
   CWP = (CWP+0x10);
-  if (CWP == WIM) trap_reg_window_underflow(DATA_PORT, RB, WIM);
-
-  //copy in and local from buffer
-  for (int i=16; i<32; i++) {
-    REGS[i] = RB.read((CWP + i) & 0xFF);
-  }
+  if (CWP == WIM) trap_reg_window_underflow(DATA_PORT, RB, WIM, SPILLED);
 
   writeReg(rd, tmp);
   dbg_printf(C_INVERSE "CWP: %d" C_RESET LF, CWP>>4);
@@ -1544,16 +1514,12 @@ void ac_behavior( mulscc_reg )
 {
   dbg_printf("mulscc_reg r%d, r%d, r%d\n", rs1, rs2, rd);
   int rs1_0 = readReg(rs1) & 1;
-  int op1 = ((PSR_icc_n ^ PSR_icc_v) << 31) | (readReg(rs1) >> 1);
+  unsigned int icc = read_icc();
+  int op1 = ((((icc >> 3) ^ (icc >> 1)) & 1) << 31) | (readReg(rs1) >> 1);
   int op2 = ((Y.read() & 1) == 0) ? 0 : readReg(rs2);
   int dest = op1+op2;
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( op1 &  op2 & ~dest & 0x80000000) |
-	       (~op1 & ~op2 &  dest & 0x80000000) );
-  PSR_icc_c = (( op1 &  op2 & 0x80000000) |
-	       (~dest & (op1 | op2) & 0x80000000) );
+  set_icc(CC_OP_ADD, op1, op2, dest);
 
   writeReg(rd, dest);
   Y.write( (rs1_0 << 31) | (Y.read() >> 1));
@@ -1565,16 +1531,12 @@ void ac_behavior( mulscc_imm )
 {
   dbg_printf("mulscc_imm r%d, %d, r%d\n", rs1, simm13, rd);
   int rs1_0 = readReg(rs1) & 1;
-  int op1 = ((PSR_icc_n ^ PSR_icc_v) << 31) | (readReg(rs1) >> 1);
+  unsigned int icc = read_icc();
+  int op1 = ((((icc >> 3) ^ (icc >> 1)) & 1) << 31) | (readReg(rs1) >> 1);
   int op2 = ((Y.read() & 1) == 0) ? 0 : simm13;
   int dest = op1+op2;
 
-  PSR_icc_n = dest >> 31;
-  PSR_icc_z = dest == 0;
-  PSR_icc_v = (( op1 &  op2 & ~dest & 0x80000000) |
-	       (~op1 & ~op2 &  dest & 0x80000000) );
-  PSR_icc_c = (( op1 &  op2 & 0x80000000) |
-	       (~dest & (op1 | op2) & 0x80000000) );
+  set_icc(CC_OP_ADD, op1, op2, dest);
 
   writeReg(rd, dest);
   Y.write( (rs1_0 << 31) | (Y.read() >> 1));
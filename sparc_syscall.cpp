@@ -34,38 +34,38 @@
  */
 
 #include "sparc_syscall.H"
+#include "sparc_regwin.H"
+#include <vector>
 
-#define writeReg(addr, val) REGS[addr] = (addr)? ac_word(val) : 0
-#define readReg(addr) REGS[addr]
+#define writeReg(addr, val) RB[regwin_index(CWP, addr)] = (addr)? ac_word(val) : 0
+#define readReg(addr) RB[regwin_index(CWP, addr)]
 
 // Namespace for sparc types.
 using namespace sparc_parms;
 
+#include "sparc_hostmem.H"
+
+unsigned int sparc_stack_top = AC_RAM_END - 1024;
+
 void sparc_syscall::get_buffer(int argn, unsigned char* buf, unsigned int size)
 {
   unsigned int addr = readReg(8+argn);
 
-  for (unsigned int i = 0; i<size; i++, addr++) {
-    buf[i] = DATA_PORT->read_byte(addr);
-  }
+  hostmem_read_bytes(DATA_PORT, addr, buf, size);
 }
 
 void sparc_syscall::set_buffer(int argn, unsigned char* buf, unsigned int size)
 {
   unsigned int addr = readReg(8+argn);
 
-  for (unsigned int i = 0; i<size; i++, addr++) {
-    DATA_PORT->write_byte(addr, buf[i]);
-  }
+  hostmem_write_bytes(DATA_PORT, addr, buf, size);
 }
 
 void sparc_syscall::set_buffer_noinvert(int argn, unsigned char* buf, unsigned int size)
 {
   unsigned int addr = readReg(8+argn);
 
-  for (unsigned int i = 0; i<size; i+=4, addr+=4) {
-    DATA_PORT->write(addr, *(unsigned int *) &buf[i]);
-  }
+  hostmem_write_words(DATA_PORT, addr, (ac_word*) buf, (size + 3) / 4);
 }
 
 int sparc_syscall::get_int(int argn)
@@ -88,34 +88,53 @@ void sparc_syscall::return_from_syscall()
 
 void sparc_syscall::set_prog_args(int argc, char **argv)
 {
-  int i, j, base;
-
-  unsigned int ac_argv[30];
-  char ac_argstr[512];
-
-  base = AC_RAM_END - 512;
-  for (i=0, j=0; i<argc; i++) {
-    int len = strlen(argv[i]) + 1;
-    ac_argv[i] = base + j;
-    memcpy(&ac_argstr[j], argv[i], len);
-    j += len;
-  }
-
+  unsigned int argv_base = sparc_write_prog_args(DATA_PORT, argc, argv);
 
-  writeReg(8, AC_RAM_END-512);
-  set_buffer(0, (unsigned char*) ac_argstr, 512);
-
-
-  writeReg(8, AC_RAM_END-512-120);
-  set_buffer_noinvert(0, (unsigned char*) ac_argv, 120);
-
- 
   writeReg(8, argc);
 
   //Set %o1 to the string pointers
-  writeReg(9, AC_RAM_END-512-120);
+  writeReg(9, argv_base);
 }
 
+unsigned int sparc_prog_args_image(int argc, char **argv, std::vector<unsigned char>& image,
+                                   unsigned int& base, unsigned int& stack_top)
+{
+  unsigned int str_size = 0;
+  for (int i=0; i<argc; i++)
+    str_size += strlen(argv[i]) + 1;
+
+  //Strings at the end of RAM and the argv array below them. Small argument
+  //lists keep the original 512 + 120 byte areas; larger ones take the extra
+  //room from the top of the stack.
+  unsigned int str_area = (str_size + 7) & ~7;
+  if (str_area < ARGS_STR_AREA)
+    str_area = ARGS_STR_AREA;
+  unsigned int argv_area = (4 * (argc + 1) + 7) & ~7;
+  if (argv_area < ARGS_ARGV_AREA)
+    argv_area = ARGS_ARGV_AREA;
+
+  unsigned int str_base = AC_RAM_END - str_area;
+  unsigned int argv_base = str_base - argv_area;
+
+  image.assign(argv_area + str_area, 0);
+  for (int i=0, j=0; i<argc; i++) {
+    int len = strlen(argv[i]) + 1;
+    ac_word ptr = HOSTMEM_BE32(str_base + j);
+    memcpy(&image[4 * i], &ptr, 4);
+    memcpy(&image[argv_area + j], argv[i], len);
+    j += len;
+  }
 
+  base = argv_base;
+  stack_top = AC_RAM_END - 1024 - (str_area - ARGS_STR_AREA) - (argv_area - ARGS_ARGV_AREA);
+  return argv_base;
+}
 
-
+unsigned int sparc_write_prog_args(ac_memory* mem, int argc, char **argv)
+{
+  std::vector<unsigned char> image;
+  unsigned int base;
+  unsigned int argv_base = sparc_prog_args_image(argc, argv, image, base, sparc_stack_top);
+  hostmem_write_bytes(mem, base, &image[0], image.size());
+  return argv_base;
+}
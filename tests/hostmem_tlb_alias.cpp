@@ -0,0 +1,114 @@
+/**
+ * @file      hostmem_tlb_alias.cpp
+ * @author    The ArchC Team
+ *            http://www.archc.org/
+ *
+ *            Computer Systems Laboratory (LSC)
+ *            IC-UNICAMP
+ *            http://www.lsc.ic.unicamp.br
+ *
+ * @version   1.0
+ * @date      Sun, 18 Oct 2026 10:00:00 -0300
+ *
+ * @brief     Regression check of the data TLB of sparc_hostmem.H: two
+ *            pages sharing a TLB entry must not see each other's stores.
+ *
+ * @attention Copyright (C) 2002-2026 --- The ArchC Team
+ *
+ */
+
+//Build and run from the model directory:
+//  g++ -I. -o hostmem_tlb_alias tests/hostmem_tlb_alias.cpp && ./hostmem_tlb_alias
+
+#include <cstdio>
+#include <vector>
+
+typedef unsigned int ac_word;
+typedef unsigned short ac_Hword;
+typedef unsigned long long ac_Dword;
+static const unsigned int AC_RAM_END = 8 << 20;
+
+class ac_inout_if
+{
+public:
+  virtual ~ac_inout_if() {}
+};
+
+class ac_storage: public ac_inout_if
+{
+public:
+  void* get_data() { return NULL; }
+  unsigned int get_size() { return 0; }
+};
+
+//! Port of the guest RAM: only reached for unmapped pages
+class ac_memory
+{
+public:
+  virtual ~ac_memory() {}
+  ac_inout_if* get_storage() { return NULL; }
+  virtual ac_word read(unsigned int) { return 0; }
+  virtual unsigned char read_byte(unsigned int) { return 0; }
+  virtual ac_Hword read_half(unsigned int) { return 0; }
+  virtual void write(unsigned int, ac_word) {}
+  virtual void write_byte(unsigned int, unsigned char) {}
+  virtual void write_half(unsigned int, ac_Hword) {}
+};
+
+#define SPARC_HOSTMEM_STORAGE
+#include "sparc_hostmem.H"
+
+static int failures = 0;
+
+static void check(const char* what, ac_word got, ac_word expected)
+{
+  if (got != expected) {
+    printf("FAIL %s: 0x%08x, expected 0x%08x\n", what, got, expected);
+    failures++;
+  }
+}
+
+int main()
+{
+  std::vector<unsigned char> ram(AC_RAM_END, 0);
+  ac_memory port;
+  hostmem_map(0, AC_RAM_END, &ram[0]);
+
+  //A and B share an entry of the TLB
+  const unsigned int a = 0x1000;
+  const unsigned int b = a + (TLB_ENTRIES << TLB_PAGE_BITS);
+
+  dm_write(&port, b, 0xbbbbbbbb);
+  dm_write(&port, a, 0x11111111);
+  check("load B", dm_read(&port, b), 0xbbbbbbbb);
+  dm_write(&port, a, 0x22222222);
+  check("A after store, load B, store", dm_read(&port, a), 0x22222222);
+  check("B after store, load B, store", dm_read(&port, b), 0xbbbbbbbb);
+
+  //same with the byte, half and doubleword stores
+  dm_write_byte(&port, a + 4, 0x33);
+  check("load B", dm_read_byte(&port, b + 4), 0);
+  dm_write_byte(&port, a + 4, 0x44);
+  dm_write_half(&port, a + 6, 0x5555);
+  dm_write_dword(&port, a + 8, 0x6666666677777777ULL);
+  check("A byte", dm_read_byte(&port, a + 4), 0x44);
+  check("A half", dm_read_half(&port, a + 6), 0x5555);
+  check("A dword", (ac_word) dm_read_dword(&port, a + 8), 0x77777777);
+  check("B byte", dm_read_byte(&port, b + 4), 0);
+  check("B half", dm_read_half(&port, b + 6), 0);
+  check("B dword", (ac_word) dm_read_dword(&port, b + 8), 0);
+
+  //ldstub and swap take the write path too
+  check("ldstub A", dm_ldstub(&port, a + 16), 0);
+  check("load B", dm_read(&port, b + 16), 0);
+  check("swap A", dm_swap(&port, a + 16, 0x88888888), 0xff000000);
+  check("B after swap A", dm_read(&port, b + 16), 0);
+
+  //and every page sharing the entry is dirty once written
+  check("A dirty", ram_is_dirty(a >> RAM_PAGE_BITS), 1);
+  check("B dirty", ram_is_dirty(b >> RAM_PAGE_BITS), 1);
+
+  if (failures == 0)
+    printf("hostmem_tlb_alias: ok\n");
+  return failures != 0;
+}